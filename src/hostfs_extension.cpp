@@ -14,9 +14,11 @@
 
 #include "table_functions/list_dir_recursive.hpp"
 #include "table_functions/change_dir.hpp"
+#include "table_functions/tree_diff.hpp"
 
 #include "scalar_functions/file_utils.hpp"
 #include "scalar_functions/hostfs.hpp"
+#include "scalar_functions/file_type.hpp"
 
 namespace fs = ghc::filesystem;
 
@@ -114,16 +116,26 @@ namespace duckdb {
 
         ExtensionUtil::RegisterFunction(instance, hostfs_last_modified_function);
 
+        auto hostfs_file_type_function = ScalarFunction("file_type", {LogicalType::VARCHAR}, LogicalType::VARCHAR,
+                                                        GetFileTypeScalarFun);
+        ExtensionUtil::RegisterFunction(instance, hostfs_file_type_function);
+
         // Register table functions
         TableFunctionSet list_dir_set("ls");
 
         TableFunction list_dir_default({}, ListDirRecursiveFun, ListDirBind, ListDirRecursiveState::Init);
+        list_dir_default.named_parameters["file_type"] = LogicalType::BOOLEAN;
+        list_dir_default.named_parameters["ordered"] = LogicalType::BOOLEAN;
         list_dir_set.AddFunction(list_dir_default);
 
         TableFunction list_dir_one_arg({LogicalType::VARCHAR}, ListDirRecursiveFun, ListDirBind, ListDirRecursiveState::Init);
+        list_dir_one_arg.named_parameters["file_type"] = LogicalType::BOOLEAN;
+        list_dir_one_arg.named_parameters["ordered"] = LogicalType::BOOLEAN;
         list_dir_set.AddFunction(list_dir_one_arg);
 
         TableFunction list_dir_two_arg({LogicalType::VARCHAR, LogicalType::BOOLEAN}, ListDirRecursiveFun, ListDirBind, ListDirRecursiveState::Init);
+        list_dir_two_arg.named_parameters["file_type"] = LogicalType::BOOLEAN;
+        list_dir_two_arg.named_parameters["ordered"] = LogicalType::BOOLEAN;
         list_dir_set.AddFunction(list_dir_two_arg);
 
         ExtensionUtil::RegisterFunction(instance, list_dir_set);
@@ -132,15 +144,23 @@ namespace duckdb {
         TableFunctionSet list_dir_recursive_set("lsr");
 
         TableFunction list_dir_recursive_default({}, ListDirRecursiveFun, ListDirRecursiveBind, ListDirRecursiveState::Init);
+        list_dir_recursive_default.named_parameters["file_type"] = LogicalType::BOOLEAN;
+        list_dir_recursive_default.named_parameters["ordered"] = LogicalType::BOOLEAN;
         list_dir_recursive_set.AddFunction(list_dir_recursive_default);
 
         TableFunction list_dir_recursive_one_arg({LogicalType::VARCHAR}, ListDirRecursiveFun, ListDirRecursiveBind, ListDirRecursiveState::Init);
+        list_dir_recursive_one_arg.named_parameters["file_type"] = LogicalType::BOOLEAN;
+        list_dir_recursive_one_arg.named_parameters["ordered"] = LogicalType::BOOLEAN;
         list_dir_recursive_set.AddFunction(list_dir_recursive_one_arg);
 
         TableFunction list_dir_recursive_two_args({LogicalType::VARCHAR, LogicalType::INTEGER}, ListDirRecursiveFun, ListDirRecursiveBind, ListDirRecursiveState::Init);
+        list_dir_recursive_two_args.named_parameters["file_type"] = LogicalType::BOOLEAN;
+        list_dir_recursive_two_args.named_parameters["ordered"] = LogicalType::BOOLEAN;
         list_dir_recursive_set.AddFunction(list_dir_recursive_two_args);
 
         TableFunction list_dir_recursive_tree_args({LogicalType::VARCHAR, LogicalType::INTEGER, LogicalType::BOOLEAN}, ListDirRecursiveFun, ListDirRecursiveBind, ListDirRecursiveState::Init);
+        list_dir_recursive_tree_args.named_parameters["file_type"] = LogicalType::BOOLEAN;
+        list_dir_recursive_tree_args.named_parameters["ordered"] = LogicalType::BOOLEAN;
         list_dir_recursive_set.AddFunction(list_dir_recursive_tree_args);
 
         ExtensionUtil::RegisterFunction(instance, list_dir_recursive_set);
@@ -149,6 +169,11 @@ namespace duckdb {
         TableFunction change_dir("cd", {LogicalType::VARCHAR}, ChangeDirFun, ChangeDirBind, ChangeDirState::Init);
         ExtensionUtil::RegisterFunction(instance, change_dir);
 
+        TableFunction tree_diff("tree_diff", {LogicalType::VARCHAR, LogicalType::VARCHAR}, TreeDiffFun, TreeDiffBind,
+                                TreeDiffState::Init, TreeDiffLocalState::Init);
+        tree_diff.named_parameters["compare"] = LogicalType::VARCHAR;
+        ExtensionUtil::RegisterFunction(instance, tree_diff);
+
         // Pragma functions
 
         PragmaFunction cd = PragmaFunction::PragmaCall("cd", PragmaChangeDir, {LogicalType::VARCHAR});
@@ -0,0 +1,381 @@
+#pragma once
+
+
+#include "hostfs_extension.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/function/scalar_function.hpp"
+
+#include <cstring>    // for std::memcmp
+#include <exception>  // for std::exception_ptr
+#include <mutex>      // for std::mutex
+#include <system_error> // for std::system_error
+#include <thread>     // for std::thread
+
+#ifdef _WIN32
+#include <cstdio>     // for std::fopen, std::fread
+#else
+#include <fcntl.h>    // for open
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for pread, close
+#endif
+
+namespace fs = ghc::filesystem;
+
+namespace duckdb {
+
+    // number of leading bytes read per file, large enough to reach the tar header at offset 257
+    static constexpr idx_t FILE_TYPE_HEAD_SIZE = 512;
+
+    // when the reads of a chunk are spread over threads, each thread takes at least this many paths
+    static constexpr idx_t FILE_TYPE_MIN_READS = 64;
+
+    struct FileSignature {
+        const char *type;
+        idx_t offset;
+        const char *magic;
+        idx_t magic_len;
+    };
+
+    // Checked in order, so longer and more specific signatures come before shorter ones. Everything in here
+    // must be unlikely to start a text file, weaker magics go into WEAK_FILE_SIGNATURES.
+    static constexpr FileSignature FILE_SIGNATURES[] = {
+            {"parquet",  0,   "PAR1",                       4},
+            {"gzip",     0,   "\x1f\x8b",                   2},
+            {"zstd",     0,   "\x28\xb5\x2f\xfd",           4},
+            {"xz",       0,   "\xfd\x37\x7a\x58\x5a\x00",   6},
+            {"lz4",      0,   "\x04\x22\x4d\x18",           4},
+            {"7z",       0,   "7z\xbc\xaf\x27\x1c",         6},
+            {"zip",      0,   "PK\x03\x04",                 4},
+            {"zip",      0,   "PK\x05\x06",                 4},
+            {"tar",      257, "ustar",                      5},
+            {"duckdb",   8,   "DUCK",                       4},
+            {"sqlite",   0,   "SQLite format 3\x00",        16},
+            {"arrow",    0,   "ARROW1",                     6},
+            {"avro",     0,   "Obj\x01",                    4},
+            {"elf",      0,   "\x7f" "ELF",                 4},
+            {"macho",    0,   "\xcf\xfa\xed\xfe",           4},
+            {"macho",    0,   "\xce\xfa\xed\xfe",           4},
+            {"macho",    0,   "\xca\xfe\xba\xbe",           4},
+            {"png",      0,   "\x89PNG\r\n\x1a\n",          8},
+            {"jpeg",     0,   "\xff\xd8\xff",               3},
+            {"gif",      0,   "GIF87a",                     6},
+            {"gif",      0,   "GIF89a",                     6},
+            {"pdf",      0,   "%PDF-",                      5},
+            {"xml",      0,   "<?xml",                      5},
+    };
+
+    // only checked once the buffer is known not to be text, "ORC" and "MZ" can just as well start a text file
+    static constexpr FileSignature WEAK_FILE_SIGNATURES[] = {
+            {"orc",      0,   "ORC",                        3},
+            {"pe",       0,   "MZ",                         2},
+    };
+
+    static bool MatchesSignature(const FileSignature &signature, const_data_ptr_t buffer, idx_t size) {
+        return signature.offset + signature.magic_len <= size &&
+               std::memcmp(buffer + signature.offset, signature.magic, signature.magic_len) == 0;
+    }
+
+    // "BZh", the block size digit and then either the first block or the end of stream marker
+    static bool IsBzip2Head(const_data_ptr_t buffer, idx_t size) {
+        if (size < 10 || std::memcmp(buffer, "BZh", 3) != 0 || buffer[3] < '1' || buffer[3] > '9') {
+            return false;
+        }
+        return std::memcmp(buffer + 4, "1AY&SY", 6) == 0 ||
+               std::memcmp(buffer + 4, "\x17\x72\x45\x38\x50\x90", 6) == 0;
+    }
+
+    // After an opening bracket, JSON continues with a value (or the closing bracket), while e.g. INI
+    // sections ("[section]") continue with a bare word.
+    static bool LooksLikeJSON(const_data_ptr_t buffer, idx_t size, idx_t first) {
+        auto open = buffer[first];
+        if (open != '{' && open != '[') {
+            return false;
+        }
+        idx_t next = first + 1;
+        while (next < size && StringUtil::CharacterIsSpace(static_cast<char>(buffer[next]))) {
+            next++;
+        }
+        if (next == size) {
+            // only whitespace in the sniffed range, give the bracket the benefit of the doubt
+            return true;
+        }
+        auto c = static_cast<char>(buffer[next]);
+        if (open == '{') {
+            return c == '"' || c == '}';
+        }
+        if (c == '"' || c == '{' || c == '[' || c == ']' || c == '-' || (c >= '0' && c <= '9')) {
+            return true;
+        }
+        for (auto literal: {"true", "false", "null"}) {
+            auto length = std::strlen(literal);
+            if (next + length <= size && std::memcmp(buffer + next, literal, length) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool IsTextBuffer(const_data_ptr_t buffer, idx_t size) {
+        // NUL bytes and most C0 control characters never show up in text files
+        for (idx_t i = 0; i < size; i++) {
+            auto c = buffer[i];
+            if (c == 0 || (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != 0x1b)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool LooksLikeCSV(const_data_ptr_t buffer, idx_t size) {
+        static constexpr char DELIMITERS[] = {',', '\t', ';', '|'};
+
+        for (auto delimiter: DELIMITERS) {
+            // count the delimiters per line, ignoring those inside quotes
+            idx_t expected = 0;
+            idx_t current = 0;
+            idx_t lines = 0;
+            bool in_line = false;
+            bool in_quotes = false;
+            bool consistent = true;
+            auto end_line = [&]() {
+                if (lines == 0) {
+                    expected = current;
+                } else if (current != expected) {
+                    consistent = false;
+                }
+                lines++;
+                current = 0;
+                in_line = false;
+            };
+            for (idx_t i = 0; i < size && consistent; i++) {
+                auto c = static_cast<char>(buffer[i]);
+                if (!in_quotes && c == '\n') {
+                    end_line();
+                    continue;
+                }
+                in_line = true;
+                if (c == '"') {
+                    in_quotes = !in_quotes;
+                } else if (!in_quotes && c == delimiter) {
+                    current++;
+                }
+            }
+            // a buffer shorter than FILE_TYPE_HEAD_SIZE holds the whole file, so its last line is complete
+            // even without a trailing newline, while in a truncated buffer it is cut off and not checked
+            bool whole_file = size < FILE_TYPE_HEAD_SIZE;
+            if (consistent && in_line && whole_file) {
+                end_line();
+            }
+            // a single line only counts as a header-only file if nothing was cut off after it
+            if (consistent && expected > 0 && (lines >= 2 || (lines == 1 && whole_file))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static const char *ClassifyFileHead(const_data_ptr_t buffer, idx_t size) {
+        if (size == 0) {
+            return "empty";
+        }
+
+        for (auto &signature: FILE_SIGNATURES) {
+            if (MatchesSignature(signature, buffer, size)) {
+                return signature.type;
+            }
+        }
+        if (IsBzip2Head(buffer, size)) {
+            return "bzip2";
+        }
+
+        // skip a UTF-8 byte order mark before looking at the text heuristics
+        idx_t start = 0;
+        if (size >= 3 && buffer[0] == 0xef && buffer[1] == 0xbb && buffer[2] == 0xbf) {
+            start = 3;
+        }
+        if (!IsTextBuffer(buffer + start, size - start)) {
+            for (auto &signature: WEAK_FILE_SIGNATURES) {
+                if (MatchesSignature(signature, buffer, size)) {
+                    return signature.type;
+                }
+            }
+            return "binary";
+        }
+
+        idx_t first = start;
+        while (first < size && StringUtil::CharacterIsSpace(static_cast<char>(buffer[first]))) {
+            first++;
+        }
+        if (first < size && LooksLikeJSON(buffer, size, first)) {
+            return "json";
+        }
+        if (LooksLikeCSV(buffer + start, size - start)) {
+            return "csv";
+        }
+        return "text";
+    }
+
+    // Reads up to FILE_TYPE_HEAD_SIZE bytes of the file into the buffer and classifies them.
+    // Returns nullptr if the path can not be opened.
+    static const char *SniffFileType(const std::string &path, data_ptr_t buffer) {
+#ifdef _WIN32
+        std::error_code ec;
+        auto status = fs::status(path, ec);
+        if (ec || !fs::exists(status)) {
+            return nullptr;
+        }
+        if (fs::is_directory(status)) {
+            return "directory";
+        }
+        if (!fs::is_regular_file(status)) {
+            return "other";
+        }
+        auto file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            return nullptr;
+        }
+        auto size = std::fread(buffer, 1, FILE_TYPE_HEAD_SIZE, file);
+        std::fclose(file);
+        return ClassifyFileHead(buffer, size);
+#else
+        // O_NONBLOCK keeps fifos from blocking the open, they are reported as "other" below
+        int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        const char *type;
+        if (fstat(fd, &st) != 0) {
+            type = nullptr;
+        } else if (S_ISDIR(st.st_mode)) {
+            type = "directory";
+        } else if (!S_ISREG(st.st_mode)) {
+            type = "other";
+        } else {
+            ssize_t size = pread(fd, buffer, FILE_TYPE_HEAD_SIZE, 0);
+            type = size < 0 ? nullptr : ClassifyFileHead(buffer, static_cast<idx_t>(size));
+        }
+        close(fd);
+        return type;
+#endif
+    }
+
+    // Sniffs a chunk of paths, types[i] is left untouched for rows where get_path returns false. With
+    // max_threads > 1 the reads are spread over up to that many threads, so their open/pread latencies
+    // overlap. Each thread reuses its own read and path buffers.
+    template <class GET_PATH>
+    static void SniffFileTypes(idx_t count, GET_PATH &&get_path, const char **types, idx_t max_threads = 1) {
+        auto sniff_range = [&](idx_t begin, idx_t end) {
+            data_t buffer[FILE_TYPE_HEAD_SIZE];
+            std::string path;
+            string_t path_data;
+            for (idx_t i = begin; i < end; i++) {
+                if (get_path(i, path_data)) {
+                    path.assign(path_data.GetData(), path_data.GetSize());
+                    types[i] = SniffFileType(path, buffer);
+                }
+            }
+        };
+
+        idx_t thread_count = std::min<idx_t>(max_threads, count / FILE_TYPE_MIN_READS);
+        if (thread_count <= 1) {
+            sniff_range(0, count);
+            return;
+        }
+
+        // exceptions never leave a thread body, the first one is rethrown once all threads are joined
+        std::mutex error_lock;
+        std::exception_ptr error;
+        auto guarded_range = [&](idx_t begin, idx_t end) {
+            try {
+                sniff_range(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(error_lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        idx_t range_size = (count + thread_count - 1) / thread_count;
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        idx_t begin = range_size;
+        for (; begin < count; begin += range_size) {
+            try {
+                threads.emplace_back(guarded_range, begin, std::min<idx_t>(begin + range_size, count));
+            } catch (const std::system_error &) {
+                // no more threads available, the calling thread reads the remaining ranges itself
+                break;
+            }
+        }
+        guarded_range(0, range_size);
+        for (; begin < count; begin += range_size) {
+            guarded_range(begin, std::min<idx_t>(begin + range_size, count));
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Writes sniffed types into a flat VARCHAR vector, NULL where the type is unknown.
+    static void SetFileTypes(const char *const *types, idx_t count, Vector &result) {
+        auto result_data = FlatVector::GetData<string_t>(result);
+        auto &result_mask = FlatVector::Validity(result);
+        for (idx_t i = 0; i < count; i++) {
+            if (!types[i]) {
+                result_mask.SetInvalid(i);
+                continue;
+            }
+            // all type names fit into an inlined string_t, so no heap allocation happens here
+            result_data[i] = StringVector::AddString(result, types[i]);
+        }
+    }
+
+    static void GetFileTypeScalarFun(DataChunk &input, ExpressionState &state, Vector &result) {
+        auto &path_vector = input.data[0];
+        auto count = input.size();
+
+        // a constant path is sniffed once
+        if (path_vector.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+            if (ConstantVector::IsNull(path_vector)) {
+                ConstantVector::SetNull(result, true);
+                return;
+            }
+            data_t buffer[FILE_TYPE_HEAD_SIZE];
+            auto type = SniffFileType(ConstantVector::GetData<string_t>(path_vector)->GetString(), buffer);
+            if (!type) {
+                ConstantVector::SetNull(result, true);
+                return;
+            }
+            *ConstantVector::GetData<string_t>(result) = StringVector::AddString(result, type);
+            return;
+        }
+
+        UnifiedVectorFormat path_format;
+        path_vector.ToUnifiedFormat(count, path_format);
+        auto path_data = UnifiedVectorFormat::GetData<string_t>(path_format);
+
+        // The scalar already runs on every DuckDB worker thread, so the chunk is read sequentially here.
+        // NULL paths stay NULL, as do paths that can not be opened.
+        const char *types[STANDARD_VECTOR_SIZE] = {};
+        SniffFileTypes(count, [&](idx_t i, string_t &path) {
+            auto idx = path_format.sel->get_index(i);
+            if (!path_format.validity.RowIsValid(idx)) {
+                return false;
+            }
+            path = path_data[idx];
+            return true;
+        }, types);
+
+        result.SetVectorType(VectorType::FLAT_VECTOR);
+        SetFileTypes(types, count, result);
+    }
+
+}
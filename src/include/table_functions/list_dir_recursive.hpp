@@ -7,14 +7,18 @@
 #include "duckdb/common/string_util.hpp"
 #include "duckdb/function/scalar_function.hpp"
 #include "duckdb/main/extension_util.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
 
 #include <chrono>      // for std::chrono::duration_cast
 #include <ctime>  // for std::time_t
 
 #include <iomanip>    // for std::fixed and std::setprecision
+#include <algorithm>  // for std::sort
 #include <utility>
 
+#include "scalar_functions/file_type.hpp"
+
 namespace fs = ghc::filesystem;
 
 namespace duckdb {
@@ -25,21 +29,46 @@ namespace duckdb {
         string directory;
         int depth; // -1 for infinite depth, 0 for no recursion
         bool skip_permission_denied;
+        bool file_type; // adds a file_type column sniffed from the leading bytes of each file
+        bool ordered; // emit paths in lexicographic order, streaming one sorted directory at a time
 
-        explicit ListDirRecursiveFunctionData(string directory, int depth, bool skip_permission_denied) : directory(
-                std::move(directory)), depth(depth), skip_permission_denied(skip_permission_denied) {}
+        explicit ListDirRecursiveFunctionData(string directory, int depth, bool skip_permission_denied,
+                                              bool file_type = false, bool ordered = false) : directory(
+                std::move(directory)), depth(depth), skip_permission_denied(skip_permission_denied),
+                                                                        file_type(file_type), ordered(ordered) {}
 
         unique_ptr<FunctionData> Copy() const override {
-            return make_uniq<ListDirRecursiveFunctionData>(directory, depth, skip_permission_denied);
+            return make_uniq<ListDirRecursiveFunctionData>(directory, depth, skip_permission_denied, file_type,
+                                                           ordered);
         }
 
         bool Equals(const FunctionData &other) const override {
             return directory == other.Cast<ListDirRecursiveFunctionData>().directory &&
-                   depth == other.Cast<ListDirRecursiveFunctionData>().depth;
+                   depth == other.Cast<ListDirRecursiveFunctionData>().depth &&
+                   file_type == other.Cast<ListDirRecursiveFunctionData>().file_type &&
+                   ordered == other.Cast<ListDirRecursiveFunctionData>().ordered;
+
+        }
+    };
+
+    // An entry of a directory, or the subtree below it. Subtrees sort by "name/", so that together with
+    // the per-directory sort the emitted full paths come out in plain lexicographic order.
+    struct ListDirOrderedItem {
+        std::string key;
+        bool subtree;
 
+        bool operator<(const ListDirOrderedItem &other) const {
+            return key < other.key;
         }
     };
 
+    struct ListDirOrderedLevel {
+        fs::path directory;
+        int depth; // depth of the entries in this directory, 0 for the children of the root
+        std::vector<ListDirOrderedItem> items;
+        idx_t next_idx = 0;
+    };
+
     struct ListDirRecursiveState final : GlobalTableFunctionState {
         ListDirRecursiveState() : gathered_paths(false), paths(), current_idx(0) {}
 
@@ -47,11 +76,29 @@ namespace duckdb {
         std::vector<std::string> paths;
         idx_t current_idx = 0;
 
+        // the open directories of the ordered walk, only as deep as the current path
+        std::vector<ListDirOrderedLevel> ordered_levels;
+
         static unique_ptr<GlobalTableFunctionState> Init(ClientContext &context, TableFunctionInitInput &input) {
             return make_uniq<ListDirRecursiveState>();
         }
     };
 
+    static bool ListDirNamedFlag(TableFunctionBindInput &input, const string &name) {
+        auto entry = input.named_parameters.find(name);
+        return entry != input.named_parameters.end() && !entry->second.IsNull() && entry->second.GetValue<bool>();
+    }
+
+    static bool ListDirBindFileType(TableFunctionBindInput &input, vector<LogicalType> &return_types,
+                                    vector<string> &names) {
+        if (!ListDirNamedFlag(input, "file_type")) {
+            return false;
+        }
+        names.emplace_back("file_type");
+        return_types.emplace_back(LogicalType::VARCHAR);
+        return true;
+    }
+
     static unique_ptr<FunctionData> ListDirRecursiveBind(ClientContext &context, TableFunctionBindInput &input,
                                                          vector<LogicalType> &return_types, vector<string> &names) {
         names.emplace_back("path");
@@ -72,7 +119,12 @@ namespace duckdb {
             skip_permission_denied = input.inputs[2].GetValue<bool>();
         }
 
-        auto data = make_uniq<ListDirRecursiveFunctionData>(directory, depth, skip_permission_denied);
+        auto file_type = ListDirBindFileType(input, return_types, names);
+
+        auto ordered = ListDirNamedFlag(input, "ordered");
+
+        auto data = make_uniq<ListDirRecursiveFunctionData>(directory, depth, skip_permission_denied, file_type,
+                                                            ordered);
         return std::move(data);
     }
 
@@ -91,18 +143,26 @@ namespace duckdb {
             skip_permission_denied = input.inputs[1].GetValue<bool>();
         }
 
-        auto data = make_uniq<ListDirRecursiveFunctionData>(directory, 0, skip_permission_denied);
+        auto file_type = ListDirBindFileType(input, return_types, names);
+
+        auto ordered = ListDirNamedFlag(input, "ordered");
+
+        auto data = make_uniq<ListDirRecursiveFunctionData>(directory, 0, skip_permission_denied, file_type, ordered);
         return std::move(data);
     }
 
+    void CheckListDirectory(const std::string &directory) {
+        // Check if the directory exists and is valid
+        if (!fs::exists(directory) ){
+            throw IOException("Directory does not exist: " + directory);
+        } else if (!fs::is_directory(directory)) {
+            throw IOException("Path is not a directory: " + directory);
+        }
+    }
+
     void ListDirectoryRecursive(const std::string &directory, std::vector<std::string> &paths, int max_depth, bool skip_permission_denied) {
         try {
-            // Check if the directory exists and is valid
-            if (!fs::exists(directory) ){
-                throw IOException("Directory does not exist: " + directory);
-            } else if (!fs::is_directory(directory)) {
-                throw IOException("Path is not a directory: " + directory);
-            }
+            CheckListDirectory(directory);
 
             auto options = fs::directory_options::none;
             if (skip_permission_denied) {
@@ -126,6 +186,55 @@ namespace duckdb {
         }
     }
 
+    // Reads and sorts a single directory, so the sorts stay small no matter how large the tree is.
+    void PushOrderedLevel(std::vector<ListDirOrderedLevel> &levels, const fs::path &directory, int depth,
+                          int max_depth, bool skip_permission_denied) {
+        auto options = fs::directory_options::none;
+        if (skip_permission_denied) {
+            options = fs::directory_options::skip_permission_denied;
+        }
+
+        ListDirOrderedLevel level;
+        level.directory = directory;
+        level.depth = depth;
+        try {
+            for (fs::directory_iterator it(directory, options), end; it != end; ++it) {
+                auto name = it->path().filename().string();
+                // like recursive_directory_iterator, do not follow directory symlinks
+                bool recurse = it->symlink_status().type() == fs::file_type::directory &&
+                               (max_depth == -1 || depth + 1 <= max_depth);
+                if (recurse) {
+                    level.items.push_back(ListDirOrderedItem {name + "/", true});
+                }
+                level.items.push_back(ListDirOrderedItem {std::move(name), false});
+            }
+        } catch (const std::exception &ex) {
+            throw IOException(ex.what());
+        }
+        std::sort(level.items.begin(), level.items.end());
+        levels.push_back(std::move(level));
+    }
+
+    // Continues the depth-first ordered walk until count paths are gathered or the tree is exhausted.
+    void ListDirectoryOrdered(std::vector<ListDirOrderedLevel> &levels, std::vector<std::string> &paths, idx_t count,
+                              int max_depth, bool skip_permission_denied) {
+        while (paths.size() < count && !levels.empty()) {
+            auto &level = levels.back();
+            if (level.next_idx == level.items.size()) {
+                levels.pop_back();
+                continue;
+            }
+            auto &item = level.items[level.next_idx++];
+            if (item.subtree) {
+                auto subdirectory = level.directory / item.key.substr(0, item.key.size() - 1);
+                // level is invalidated by the push below
+                PushOrderedLevel(levels, subdirectory, level.depth + 1, max_depth, skip_permission_denied);
+            } else {
+                paths.push_back((level.directory / item.key).string());
+            }
+        }
+    }
+
     static void ListDirRecursiveFun(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
 
         // get the args
@@ -136,8 +245,21 @@ namespace duckdb {
 
         auto &state = data_p.global_state->Cast<ListDirRecursiveState>();
 
-        // gather the paths if not already done
-        if (!state.gathered_paths.exchange(true)) {
+        if (function_data.ordered) {
+            // stream the next sorted batch, only the directories on the current path are held in memory
+            if (!state.gathered_paths.exchange(true)) {
+                try {
+                    CheckListDirectory(directory);
+                } catch (const fs::filesystem_error &ex) {
+                    throw IOException(ex.what());
+                }
+                PushOrderedLevel(state.ordered_levels, directory, 0, depth, skip_permission_denied);
+            }
+            state.paths.clear();
+            state.current_idx = 0;
+            ListDirectoryOrdered(state.ordered_levels, state.paths, STANDARD_VECTOR_SIZE, depth,
+                                 skip_permission_denied);
+        } else if (!state.gathered_paths.exchange(true)) {
             // first call, gather the paths
             ListDirectoryRecursive(directory, state.paths, depth, skip_permission_denied);
         }
@@ -156,6 +278,18 @@ namespace duckdb {
             output.data[0].SetValue(index, Value(path_str));
         }
 
+        // sniff the file types of the whole chunk at once. The scan itself is single-threaded, so the reads
+        // are spread over as many threads as DuckDB is configured to use.
+        if (function_data.file_type) {
+            const char *types[STANDARD_VECTOR_SIZE] = {};
+            auto paths = state.paths.data() + state.current_idx;
+            SniffFileTypes(count, [&](idx_t i, string_t &path) {
+                path = string_t(paths[i].data(), static_cast<uint32_t>(paths[i].size()));
+                return true;
+            }, types, TaskScheduler::GetScheduler(context).NumberOfThreads());
+            SetFileTypes(types, count, output.data[1]);
+        }
+
         // update the current index
         state.current_idx += count;
 
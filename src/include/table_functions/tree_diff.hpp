@@ -0,0 +1,380 @@
+#pragma once
+
+
+#include "hostfs_extension.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+
+#include <algorithm>          // for std::sort
+#include <condition_variable> // for std::condition_variable
+#include <cstring>            // for std::memcmp
+#include <fstream>            // for std::ifstream
+#include <mutex>              // for std::mutex
+#include <utility>
+
+namespace fs = ghc::filesystem;
+
+namespace duckdb {
+
+    struct TreeDiffFunctionData final : FunctionData {
+
+        string left;
+        string right;
+        bool compare_size;
+        bool compare_mtime;
+        bool compare_content; // compare := 'hash', files with equal sizes are compared byte by byte
+
+        TreeDiffFunctionData(string left, string right, bool compare_size, bool compare_mtime, bool compare_content)
+                : left(std::move(left)), right(std::move(right)), compare_size(compare_size),
+                  compare_mtime(compare_mtime), compare_content(compare_content) {}
+
+        unique_ptr<FunctionData> Copy() const override {
+            return make_uniq<TreeDiffFunctionData>(left, right, compare_size, compare_mtime, compare_content);
+        }
+
+        bool Equals(const FunctionData &other) const override {
+            auto &other_data = other.Cast<TreeDiffFunctionData>();
+            return left == other_data.left && right == other_data.right &&
+                   compare_size == other_data.compare_size && compare_mtime == other_data.compare_mtime &&
+                   compare_content == other_data.compare_content;
+        }
+    };
+
+    // A directory relative to both roots. If only one side has it, its whole subtree is added or removed.
+    struct TreeDiffWorkItem {
+        std::string relative_path;
+        bool has_left;
+        bool has_right;
+    };
+
+    struct TreeDiffRow {
+        std::string path;
+        const char *status;
+        const char *type;
+    };
+
+    struct TreeDiffEntry {
+        std::string name;
+        fs::file_type type;
+
+        bool operator<(const TreeDiffEntry &other) const {
+            return name < other.name;
+        }
+    };
+
+    struct TreeDiffState final : GlobalTableFunctionState {
+        explicit TreeDiffState(idx_t max_threads) : max_threads(max_threads), active_workers(0) {}
+
+        idx_t max_threads;
+
+        // Directories still to be compared. Used as a stack so the walk stays depth-first: it holds the not yet
+        // visited subdirectories of every directory on the current paths, i.e. depth times fan-out, not the
+        // whole tree.
+        std::mutex lock;
+        std::condition_variable work_available;
+        std::vector<TreeDiffWorkItem> pending;
+        idx_t active_workers;
+
+        idx_t MaxThreads() const override {
+            return max_threads;
+        }
+
+        static unique_ptr<GlobalTableFunctionState> Init(ClientContext &context, TableFunctionInitInput &input) {
+            auto &bind_data = input.bind_data->Cast<TreeDiffFunctionData>();
+            auto state = make_uniq<TreeDiffState>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+
+            // identical roots can not differ, skip the walk entirely
+            std::error_code ec;
+            if (!fs::equivalent(bind_data.left, bind_data.right, ec)) {
+                state->pending.push_back(TreeDiffWorkItem {"", true, true});
+            }
+            return std::move(state);
+        }
+
+        // Blocks until a directory is available or all workers are idle with nothing left to do.
+        bool Next(TreeDiffWorkItem &item) {
+            std::unique_lock<std::mutex> guard(lock);
+            while (pending.empty() && active_workers > 0) {
+                work_available.wait(guard);
+            }
+            if (pending.empty()) {
+                return false;
+            }
+            item = std::move(pending.back());
+            pending.pop_back();
+            active_workers++;
+            return true;
+        }
+
+        void Finish(vector<TreeDiffWorkItem> &children) {
+            std::lock_guard<std::mutex> guard(lock);
+            // push in reverse so the lexicographically first subdirectory is popped next
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                pending.push_back(std::move(*it));
+            }
+            active_workers--;
+            work_available.notify_all();
+        }
+    };
+
+    struct TreeDiffLocalState final : LocalTableFunctionState {
+        // the differences of the last compared directory, at most one row per entry of that directory
+        std::vector<TreeDiffRow> rows;
+        idx_t current_idx = 0;
+
+        static unique_ptr<LocalTableFunctionState> Init(ExecutionContext &context, TableFunctionInitInput &input,
+                                                        GlobalTableFunctionState *global_state) {
+            return make_uniq<TreeDiffLocalState>();
+        }
+    };
+
+    static const char *TreeDiffTypeName(fs::file_type type) {
+        switch (type) {
+            case fs::file_type::directory:
+                return "directory";
+            case fs::file_type::regular:
+                return "file";
+            case fs::file_type::symlink:
+                return "symlink";
+            default:
+                return "other";
+        }
+    }
+
+    static std::string TreeDiffJoin(const std::string &relative_path, const std::string &name) {
+        return relative_path.empty() ? name : relative_path + "/" + name;
+    }
+
+    // Lists a single directory level sorted by name. Symlinks are not followed. Any listing error is
+    // raised, a partial listing would show up as entries added or removed on the other side.
+    static void TreeDiffListDirectory(const fs::path &directory, std::vector<TreeDiffEntry> &entries) {
+        try {
+            for (fs::directory_iterator it(directory), end; it != end; ++it) {
+                entries.push_back(TreeDiffEntry {it->path().filename().string(), it->symlink_status().type()});
+            }
+        } catch (const std::exception &ex) {
+            throw IOException(ex.what());
+        }
+        std::sort(entries.begin(), entries.end());
+    }
+
+    static bool TreeDiffSameContent(const fs::path &left, const fs::path &right) {
+        static constexpr std::streamsize BLOCK_SIZE = 64 * 1024;
+
+        std::ifstream left_stream(left.string(), std::ios::binary);
+        std::ifstream right_stream(right.string(), std::ios::binary);
+        if (!left_stream) {
+            throw IOException("Could not open file: " + left.string());
+        } else if (!right_stream) {
+            throw IOException("Could not open file: " + right.string());
+        }
+        std::vector<char> left_block(BLOCK_SIZE);
+        std::vector<char> right_block(BLOCK_SIZE);
+        while (true) {
+            left_stream.read(left_block.data(), BLOCK_SIZE);
+            right_stream.read(right_block.data(), BLOCK_SIZE);
+            auto left_count = left_stream.gcount();
+            if (left_count != right_stream.gcount() ||
+                std::memcmp(left_block.data(), right_block.data(), left_count) != 0) {
+                return false;
+            }
+            if (left_count < BLOCK_SIZE) {
+                return true;
+            }
+        }
+    }
+
+    static bool TreeDiffFileChanged(const TreeDiffFunctionData &bind_data, const fs::path &left,
+                                    const fs::path &right) {
+        try {
+            if ((bind_data.compare_size || bind_data.compare_content) &&
+                fs::file_size(left) != fs::file_size(right)) {
+                return true;
+            }
+            if (bind_data.compare_mtime && fs::last_write_time(left) != fs::last_write_time(right)) {
+                return true;
+            }
+        } catch (const std::exception &ex) {
+            throw IOException(ex.what());
+        }
+        if (bind_data.compare_content) {
+            return !TreeDiffSameContent(left, right);
+        }
+        return false;
+    }
+
+    // Merge-walks one directory level of both trees, emitting rows for its entries and collecting the
+    // subdirectories that still have to be visited.
+    static void TreeDiffDirectory(const TreeDiffFunctionData &bind_data, const TreeDiffWorkItem &item,
+                                  std::vector<TreeDiffRow> &rows, std::vector<TreeDiffWorkItem> &children) {
+        fs::path left_dir = fs::path(bind_data.left) / item.relative_path;
+        fs::path right_dir = fs::path(bind_data.right) / item.relative_path;
+
+        std::vector<TreeDiffEntry> left_entries;
+        std::vector<TreeDiffEntry> right_entries;
+        if (item.has_left) {
+            TreeDiffListDirectory(left_dir, left_entries);
+        }
+        if (item.has_right) {
+            TreeDiffListDirectory(right_dir, right_entries);
+        }
+
+        idx_t left_idx = 0;
+        idx_t right_idx = 0;
+        while (left_idx < left_entries.size() || right_idx < right_entries.size()) {
+            bool take_left = right_idx == right_entries.size() ||
+                             (left_idx < left_entries.size() &&
+                              left_entries[left_idx].name < right_entries[right_idx].name);
+            bool take_right = left_idx == left_entries.size() ||
+                              (right_idx < right_entries.size() &&
+                               right_entries[right_idx].name < left_entries[left_idx].name);
+
+            if (take_left) {
+                auto &entry = left_entries[left_idx++];
+                auto path = TreeDiffJoin(item.relative_path, entry.name);
+                rows.push_back(TreeDiffRow {path, "removed", TreeDiffTypeName(entry.type)});
+                if (entry.type == fs::file_type::directory) {
+                    children.push_back(TreeDiffWorkItem {path, true, false});
+                }
+                continue;
+            }
+            if (take_right) {
+                auto &entry = right_entries[right_idx++];
+                auto path = TreeDiffJoin(item.relative_path, entry.name);
+                rows.push_back(TreeDiffRow {path, "added", TreeDiffTypeName(entry.type)});
+                if (entry.type == fs::file_type::directory) {
+                    children.push_back(TreeDiffWorkItem {path, false, true});
+                }
+                continue;
+            }
+
+            // present on both sides
+            auto &left_entry = left_entries[left_idx++];
+            auto &right_entry = right_entries[right_idx++];
+            auto path = TreeDiffJoin(item.relative_path, left_entry.name);
+            bool left_is_dir = left_entry.type == fs::file_type::directory;
+            bool right_is_dir = right_entry.type == fs::file_type::directory;
+
+            if (left_entry.type != right_entry.type) {
+                rows.push_back(TreeDiffRow {path, "changed", TreeDiffTypeName(right_entry.type)});
+                if (left_is_dir || right_is_dir) {
+                    children.push_back(TreeDiffWorkItem {path, left_is_dir, right_is_dir});
+                }
+            } else if (left_is_dir) {
+                // Directories with the same device and inode (bind mounts, shared snapshots) are the same
+                // directory, so nothing below them can differ. If the probe fails the subtree is walked.
+                std::error_code ec;
+                if (!fs::equivalent(left_dir / left_entry.name, right_dir / right_entry.name, ec) || ec) {
+                    children.push_back(TreeDiffWorkItem {path, true, true});
+                }
+            } else if (left_entry.type == fs::file_type::symlink) {
+                bool changed;
+                try {
+                    changed = fs::read_symlink(left_dir / left_entry.name) !=
+                              fs::read_symlink(right_dir / right_entry.name);
+                } catch (const std::exception &ex) {
+                    throw IOException(ex.what());
+                }
+                if (changed) {
+                    rows.push_back(TreeDiffRow {path, "changed", "symlink"});
+                }
+            } else if (left_entry.type == fs::file_type::regular) {
+                if (TreeDiffFileChanged(bind_data, left_dir / left_entry.name, right_dir / right_entry.name)) {
+                    rows.push_back(TreeDiffRow {path, "changed", "file"});
+                }
+            }
+        }
+    }
+
+    static unique_ptr<FunctionData> TreeDiffBind(ClientContext &context, TableFunctionBindInput &input,
+                                                 vector<LogicalType> &return_types, vector<string> &names) {
+        names.emplace_back("path");
+        return_types.emplace_back(LogicalType::VARCHAR);
+
+        names.emplace_back("status");
+        return_types.emplace_back(LogicalType::VARCHAR);
+
+        names.emplace_back("type");
+        return_types.emplace_back(LogicalType::VARCHAR);
+
+        auto left = input.inputs[0].GetValue<string>();
+        auto right = input.inputs[1].GetValue<string>();
+        try {
+            for (auto &directory: {left, right}) {
+                if (!fs::exists(directory)) {
+                    throw IOException("Directory does not exist: " + directory);
+                } else if (!fs::is_directory(directory)) {
+                    throw IOException("Path is not a directory: " + directory);
+                }
+            }
+        } catch (const fs::filesystem_error &ex) {
+            throw IOException(ex.what());
+        }
+
+        string compare = "size,mtime";
+        auto entry = input.named_parameters.find("compare");
+        if (entry != input.named_parameters.end() && !entry->second.IsNull()) {
+            compare = entry->second.GetValue<string>();
+        }
+
+        bool compare_size = false;
+        bool compare_mtime = false;
+        bool compare_content = false;
+        for (auto &option: StringUtil::Split(StringUtil::Lower(compare), ',')) {
+            StringUtil::Trim(option);
+            if (option == "size") {
+                compare_size = true;
+            } else if (option == "mtime") {
+                compare_mtime = true;
+            } else if (option == "hash") {
+                compare_content = true;
+            } else {
+                throw InvalidInputException(
+                        "tree_diff: unknown compare option '%s', expected 'size', 'mtime' or 'hash'", option);
+            }
+        }
+
+        return make_uniq<TreeDiffFunctionData>(left, right, compare_size, compare_mtime, compare_content);
+    }
+
+    static void TreeDiffFun(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+        auto &bind_data = data_p.bind_data->Cast<TreeDiffFunctionData>();
+        auto &state = data_p.global_state->Cast<TreeDiffState>();
+        auto &local_state = data_p.local_state->Cast<TreeDiffLocalState>();
+
+        // walk directories until there is something to emit or the walk is done
+        std::vector<TreeDiffWorkItem> children;
+        while (local_state.current_idx == local_state.rows.size()) {
+            local_state.rows.clear();
+            local_state.current_idx = 0;
+
+            TreeDiffWorkItem item;
+            if (!state.Next(item)) {
+                output.SetCardinality(0);
+                return;
+            }
+            children.clear();
+            try {
+                TreeDiffDirectory(bind_data, item, local_state.rows, children);
+            } catch (...) {
+                state.Finish(children);
+                throw;
+            }
+            state.Finish(children);
+        }
+
+        idx_t count = std::min<idx_t>(STANDARD_VECTOR_SIZE, local_state.rows.size() - local_state.current_idx);
+        output.SetCardinality(count);
+        for (idx_t index = 0; index < count; index++) {
+            auto &row = local_state.rows[local_state.current_idx + index];
+            output.data[0].SetValue(index, Value(row.path));
+            output.data[1].SetValue(index, Value(row.status));
+            output.data[2].SetValue(index, Value(row.type));
+        }
+        local_state.current_idx += count;
+    }
+
+}